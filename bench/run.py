@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# coding=utf-8
+
+
+import argparse
+import json
+import subprocess
+import sys
+
+
+# every benchmark prints lines of "<name>\t<ns per op>\t<ops>"
+def run_component(component: str, build_dir: str, elf_dir: str):
+    cmd = ['%s/%s/bench' % (component, build_dir)]
+    if component == 'elf-analyzer':
+        cmd.append(elf_dir)
+
+    out = subprocess.run(cmd, check=True, stdout=subprocess.PIPE,
+                         universal_newlines=True).stdout
+    results = {}
+    for line in out.splitlines():
+        name, ns_per_op, ops = line.split('\t')
+        results[name] = {'ns_per_op': float(ns_per_op), 'ops': int(ops)}
+    return results
+
+
+# returns the names of the benchmarks that got slower than threshold
+def compare(results: dict, baseline: dict, threshold: float):
+    regressions = []
+    print('%-24s %12s %12s %9s' % ('benchmark', 'baseline', 'current', 'delta'))
+    for name, current in sorted(results.items()):
+        old = baseline.get(name)
+        if old is None:
+            print('%-24s %12s %12.3f %9s' % (name, '-', current['ns_per_op'], 'new'))
+            continue
+
+        delta = (current['ns_per_op'] - old['ns_per_op']) / old['ns_per_op'] * 100
+        mark = ''
+        if delta > threshold:
+            regressions.append(name)
+            mark = ' REGRESSION'
+        print('%-24s %12.3f %12.3f %+8.1f%%%s' % (name, old['ns_per_op'],
+                                               current['ns_per_op'], delta, mark))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description='run the benchmarks and compare them with the baseline')
+    parser.add_argument('--results', required=True)
+    parser.add_argument('--baseline', required=True)
+    parser.add_argument('--threshold', type=float, default=10)
+    parser.add_argument('--elf-dir', default='/usr/bin')
+    parser.add_argument('--build-dir', default='build')
+    parser.add_argument('--flags', default='')
+    parser.add_argument('--save-baseline', action='store_true')
+    parser.add_argument('components', nargs='+')
+    args = parser.parse_args()
+
+    results = {}
+    for component in args.components:
+        results.update(run_component(component, args.build_dir, args.elf_dir))
+
+    report = {'flags': args.flags, 'results': results}
+    with open(args.results, 'w') as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+
+    if args.save_baseline:
+        with open(args.baseline, 'w') as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+        print('baseline saved to %s' % args.baseline)
+        return 0
+
+    try:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    except FileNotFoundError:
+        print('no baseline at %s, run make bench-baseline' % args.baseline)
+        compare(results, {}, args.threshold)
+        return 0
+
+    if baseline.get('flags') != args.flags:
+        print('baseline was built with "%s", now "%s"' % (baseline.get('flags'), args.flags))
+
+    regressions = compare(results, baseline['results'], args.threshold)
+    if regressions:
+        print('%d benchmark(s) slower than %g%%: %s' % (len(regressions), args.threshold,
+                                                       ', '.join(regressions)))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../src/bulk.hpp"
+#include "../src/elf.hpp"
+#include "../src/footprint.hpp"
+
+#define NR_REPEATS 5
+// fixed so that results don't depend on the machine the baseline came from
+#define BULK_WORKERS "4"
+
+// ELF files right inside dir, the walk itself is not measured
+static std::vector<std::string> list_elfs( const char* dir ) {
+    std::vector<std::string> paths;
+    DIR* d = opendir( dir );
+    if ( !d )
+        return paths;
+
+    struct dirent* ent;
+    while ( ( ent = readdir( d ) ) != NULL ) {
+        if ( ent->d_type != DT_REG )
+            continue;
+        const std::string path = std::string( dir ) + "/" + ent->d_name;
+        struct elf_file elf;
+        if ( elf_open( &elf, path.c_str( ) ) == 0 ) {
+            paths.push_back( path );
+            elf_close( &elf );
+        }
+    }
+    closedir( d );
+    return paths;
+}
+
+static std::size_t nr_regular;
+
+static int count_regular( const char*, const struct stat* st, int flag, struct FTW* ) {
+    if ( flag == FTW_F && S_ISREG( st->st_mode ) )
+        nr_regular++;
+    return 0;
+}
+
+// regular files the bulk scanner visits under dir, it follows no links either
+static std::size_t count_files( const char* dir ) {
+    nr_regular = 0;
+    nftw( dir, count_regular, 64, FTW_PHYS );
+    return nr_regular;
+}
+
+// elfdump -b -j BULK_WORKERS dir with its report thrown away
+static int run_bulk( const char* dir ) {
+    char* argv[] = { ( char* ) "-b", ( char* ) "-j", ( char* ) BULK_WORKERS, ( char* ) dir, NULL };
+    std::fflush( stdout );
+    std::fflush( stderr );
+    const int out = dup( STDOUT_FILENO ), err = dup( STDERR_FILENO );
+    const int null = open( "/dev/null", O_WRONLY | O_CLOEXEC );
+    dup2( null, STDOUT_FILENO );
+    dup2( null, STDERR_FILENO );
+    close( null );
+
+    optind = 1;
+    const int ret = bulk_main( 4, argv );
+
+    std::fflush( stdout );
+    std::fflush( stderr );
+    dup2( out, STDOUT_FILENO );
+    dup2( err, STDERR_FILENO );
+    close( out );
+    close( err );
+    return ret;
+}
+
+template <typename F>
+static double best_of( F f ) {
+    double best = 0;
+    for ( int r = 0; r < NR_REPEATS; ++r ) {
+        const auto start = std::chrono::steady_clock::now( );
+        f( );
+        const double ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now( ) - start ).count( );
+        if ( r == 0 || ns < best )
+            best = ns;
+    }
+    return best;
+}
+
+int main( int argc, char** argv ) {
+    const char* dir = argc > 1 ? argv[ 1 ] : "/usr/bin";
+    const std::vector<std::string> paths = list_elfs( dir );
+    if ( paths.empty( ) ) {
+        std::fprintf( stderr, "no ELF files in %s\n", dir );
+        return -1;
+    }
+
+    std::uint64_t sink = 0;
+
+    // open, validate and unmap every file
+    const double open_ns = best_of( [ & ]( ) {
+        for ( const std::string& path : paths ) {
+            struct elf_file elf;
+            if ( elf_open( &elf, path.c_str( ) ) == 0 ) {
+                sink += elf.phnum + elf.shnum;
+                elf_close( &elf );
+            }
+        }
+    } );
+
+    // what a scan does per file: footprint and section sizes
+    std::vector<struct elf_file> elfs( paths.size( ) );
+    for ( std::size_t i = 0; i < paths.size( ); ++i )
+        elf_open( &elfs[ i ], paths[ i ].c_str( ) );
+    const double scan_ns = best_of( [ & ]( ) {
+        for ( const struct elf_file& elf : elfs ) {
+            struct elf_footprint fp;
+            if ( elf_footprint( &elf, 0, &fp ) == 0 )
+                sink += fp.vsize;
+            sink += elf_alloc_size( &elf );
+        }
+    } );
+    for ( struct elf_file& elf : elfs )
+        elf_close( &elf );
+
+    // the whole bulk mode: directory walk, work pool, scan and report
+    const std::size_t nr_files = count_files( dir );
+    int bulk_ret = 0;
+    const double bulk_ns = best_of( [ & ]( ) {
+        bulk_ret |= run_bulk( dir );
+    } );
+    if ( bulk_ret != 0 || nr_files == 0 ) {
+        std::fprintf( stderr, "bulk scan of %s failed\n", dir );
+        return -1;
+    }
+
+    std::fprintf( stderr, "%zu files, checksum %llu\n", paths.size( ), ( unsigned long long ) sink );
+    std::printf( "elf.open\t%.3f\t%zu\n", open_ns / paths.size( ), paths.size( ) );
+    std::printf( "elf.scan\t%.3f\t%zu\n", scan_ns / paths.size( ), paths.size( ) );
+    std::printf( "elf.bulk\t%.3f\t%zu\n", bulk_ns / nr_files, nr_files );
+    return 0;
+}
@@ -0,0 +1,360 @@
+#include "bulk.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "cache.hpp"
+#include "elf.hpp"
+#include "footprint.hpp"
+#include "pool.hpp"
+
+// upper bound for -j, every worker is a thread of its own
+#define MAX_WORKERS 1024
+
+// per-worker output, merged once the pool is done
+struct worker_results {
+    std::vector<struct scan_result> files;
+    std::uint64_t failures; /* unreadable files and directories */
+};
+
+struct scan_state {
+    const scan_cache* cache;
+    std::vector<struct worker_results> workers;
+};
+
+struct scan_totals {
+    std::uint64_t files;
+    std::uint64_t elf;
+    std::uint64_t invalid;
+    std::uint64_t cached;
+    std::uint64_t failures;
+    std::uint64_t size;
+    std::uint64_t alloc_size;
+    std::uint64_t vsize;
+    std::uint64_t file_pages;
+    std::uint64_t anon_pages;
+    std::uint64_t shared_pages;
+    std::uint64_t private_pages;
+    std::uint64_t relro_pages;
+    std::uint64_t tls_size;
+};
+
+static void scan_file( struct scan_state& state, std::size_t worker, const std::string& path, bool follow ) {
+    struct worker_results& out = state.workers[ worker ];
+
+    // O_NONBLOCK keeps us from hanging if the file got replaced by a fifo
+    const int fd = open( path.c_str( ), O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK | ( follow ? 0 : O_NOFOLLOW ) );
+    if ( fd < 0 ) {
+        out.failures++;
+        return;
+    }
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) ) {
+        close( fd );
+        return;
+    }
+
+    struct scan_result r = {};
+    if ( state.cache && cache_lookup( *state.cache, path, st.st_dev, st.st_ino,
+            st.st_mtim.tv_sec, st.st_mtim.tv_nsec, st.st_size, &r ) ) {
+        close( fd );
+        out.files.push_back( r );
+        return;
+    }
+
+    r.path = path;
+    r.dev = st.st_dev;
+    r.ino = st.st_ino;
+    r.mtime_sec = st.st_mtim.tv_sec;
+    r.mtime_nsec = st.st_mtim.tv_nsec;
+    r.size = st.st_size;
+
+    // only the identification bytes are read to filter out non-ELF files
+    std::uint8_t ident[ ELF_NIDENT ];
+    r.is_elf = pread( fd, ident, ELF_NIDENT, 0 ) == ELF_NIDENT && elf_is_elf( ident, ELF_NIDENT );
+
+    struct elf_file elf;
+    if ( r.is_elf && elf_fdopen( &elf, fd ) == 0 ) {
+        struct elf_footprint fp;
+        r.valid = elf_footprint( &elf, 0, &fp ) == 0;
+        r.is64 = elf.is64;
+        r.msb = elf.msb;
+        r.type = elf.hdr.e_type;
+        r.machine = elf.hdr.e_machine;
+        r.alloc_size = elf_alloc_size( &elf );
+        r.vsize = fp.vsize;
+        r.file_pages = fp.file_pages;
+        r.anon_pages = fp.anon_pages;
+        r.shared_pages = fp.shared_pages;
+        r.private_pages = fp.private_pages;
+        r.relro_pages = fp.relro_pages;
+        r.tls_size = fp.tls_size;
+        elf_close( &elf );
+    }
+    close( fd );
+    out.files.push_back( r );
+}
+
+static void scan_dir( work_pool& pool, struct scan_state& state, std::size_t worker, const std::string& path ) {
+    DIR* dir = opendir( path.c_str( ) );
+    if ( !dir ) {
+        state.workers[ worker ].failures++;
+        return;
+    }
+
+    const std::string prefix = ( !path.empty( ) && path.back( ) == '/' ) ? path : path + "/";
+    struct dirent* ent;
+    while ( ( ent = readdir( dir ) ) != NULL ) {
+        if ( std::strcmp( ent->d_name, "." ) == 0 || std::strcmp( ent->d_name, ".." ) == 0 )
+            continue;
+
+        unsigned char type = ent->d_type;
+        if ( type == DT_UNKNOWN ) {
+            // some file systems don't fill d_type
+            struct stat st;
+            if ( fstatat( dirfd( dir ), ent->d_name, &st, AT_SYMLINK_NOFOLLOW ) != 0 )
+                continue;
+            type = S_ISDIR( st.st_mode ) ? DT_DIR : S_ISREG( st.st_mode ) ? DT_REG : DT_UNKNOWN;
+        }
+
+        // symbolic links are not followed so nothing is visited twice
+        const std::string child = prefix + ent->d_name;
+        if ( type == DT_DIR )
+            pool.push( worker, [ &state, child ]( work_pool& p, std::size_t w ) {
+                scan_dir( p, state, w, child );
+            } );
+        else if ( type == DT_REG )
+            pool.push( worker, [ &state, child ]( work_pool&, std::size_t w ) {
+                scan_file( state, w, child, false );
+            } );
+    }
+    closedir( dir );
+}
+
+// csv fields are quoted only when it is needed
+static void print_csv_field( const std::string& s ) {
+    if ( s.find_first_of( ",\"\n\r" ) == std::string::npos ) {
+        std::fputs( s.c_str( ), stdout );
+        return;
+    }
+    std::putchar( '"' );
+    for ( char c : s ) {
+        if ( c == '"' )
+            std::putchar( '"' );
+        std::putchar( c );
+    }
+    std::putchar( '"' );
+}
+
+static void print_json_string( const std::string& s ) {
+    std::putchar( '"' );
+    for ( unsigned char c : s ) {
+        if ( c == '"' || c == '\\' )
+            std::printf( "\\%c", c );
+        else if ( c < 0x20 )
+            std::printf( "\\u%04x", c );
+        else std::putchar( c );
+    }
+    std::putchar( '"' );
+}
+
+static void print_csv( const std::vector<struct scan_result>& files, const struct scan_totals& t ) {
+    std::puts( "path,class,data,type,machine,size,alloc,vsize,file,anon,shared,private,relro,tls,valid,cached" );
+    for ( const struct scan_result& r : files ) {
+        if ( !r.is_elf )
+            continue;
+        print_csv_field( r.path );
+        std::printf( ",%s,%s,%u,%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+            ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%d,%d\n",
+            r.is64 ? "ELF64" : "ELF32", r.msb ? "MSB" : "LSB", r.type, r.machine,
+            r.size, r.alloc_size, r.vsize, r.file_pages, r.anon_pages, r.shared_pages,
+            r.private_pages, r.relro_pages, r.tls_size, r.valid, r.cached );
+    }
+
+    // keep stdout a single table, totals go to stderr
+    std::fprintf( stderr, "files=%" PRIu64 " elf=%" PRIu64 " invalid=%" PRIu64 " cached=%" PRIu64
+        " failures=%" PRIu64 " size=%" PRIu64 " alloc=%" PRIu64 " vsize=%" PRIu64 " file=%" PRIu64
+        " anon=%" PRIu64 " shared=%" PRIu64 " private=%" PRIu64 " relro=%" PRIu64 " tls=%" PRIu64 "\n",
+        t.files, t.elf, t.invalid, t.cached, t.failures, t.size, t.alloc_size, t.vsize,
+        t.file_pages, t.anon_pages, t.shared_pages, t.private_pages, t.relro_pages, t.tls_size );
+}
+
+static void print_json( const std::vector<struct scan_result>& files, const struct scan_totals& t ) {
+    std::puts( "{" );
+    std::puts( "  \"files\": [" );
+    bool first = true;
+    for ( const struct scan_result& r : files ) {
+        if ( !r.is_elf )
+            continue;
+        std::fputs( first ? "    { \"path\": " : ",\n    { \"path\": ", stdout );
+        first = false;
+        print_json_string( r.path );
+        std::printf( ", \"class\": \"%s\", \"data\": \"%s\", \"type\": %u, \"machine\": %u"
+            ", \"size\": %" PRIu64 ", \"alloc\": %" PRIu64 ", \"vsize\": %" PRIu64
+            ", \"file\": %" PRIu64 ", \"anon\": %" PRIu64 ", \"shared\": %" PRIu64
+            ", \"private\": %" PRIu64 ", \"relro\": %" PRIu64 ", \"tls\": %" PRIu64
+            ", \"valid\": %s, \"cached\": %s }",
+            r.is64 ? "ELF64" : "ELF32", r.msb ? "MSB" : "LSB", r.type, r.machine,
+            r.size, r.alloc_size, r.vsize, r.file_pages, r.anon_pages, r.shared_pages,
+            r.private_pages, r.relro_pages, r.tls_size,
+            r.valid ? "true" : "false", r.cached ? "true" : "false" );
+    }
+    std::puts( first ? "  ]," : "\n  ]," );
+    std::printf( "  \"total\": { \"files\": %" PRIu64 ", \"elf\": %" PRIu64 ", \"invalid\": %" PRIu64
+        ", \"cached\": %" PRIu64 ", \"failures\": %" PRIu64 ", \"size\": %" PRIu64
+        ", \"alloc\": %" PRIu64 ", \"vsize\": %" PRIu64 ", \"file\": %" PRIu64
+        ", \"anon\": %" PRIu64 ", \"shared\": %" PRIu64 ", \"private\": %" PRIu64
+        ", \"relro\": %" PRIu64 ", \"tls\": %" PRIu64 " }\n",
+        t.files, t.elf, t.invalid, t.cached, t.failures, t.size, t.alloc_size, t.vsize,
+        t.file_pages, t.anon_pages, t.shared_pages, t.private_pages, t.relro_pages, t.tls_size );
+    std::puts( "}" );
+}
+
+// path was found by walking root, or is root itself
+static bool under_root( const std::string& path, const std::string& root ) {
+    if ( path.compare( 0, root.size( ), root ) != 0 )
+        return false;
+    return path.size( ) == root.size( ) || root.back( ) == '/' || path[ root.size( ) ] == '/';
+}
+
+static void usage( ) {
+    std::fprintf( stderr, "usage: readelf -b [-j <threads>] [-f csv|json] [-c <cache-file>] <path>...\n"
+        "       <threads> is between 1 and %d\n", MAX_WORKERS );
+}
+
+int bulk_main( int argc, char** argv ) {
+    std::size_t nr_workers = std::min<std::size_t>( std::thread::hardware_concurrency( ), MAX_WORKERS );
+    bool json = false;
+    const char* cache_path = NULL;
+
+    int opt;
+    while ( ( opt = getopt( argc, argv, "j:f:c:" ) ) != -1 ) {
+        switch ( opt ) {
+            case 'j': {
+                char* end;
+                errno = 0;
+                const long n = std::strtol( optarg, &end, 10 );
+                if ( errno != 0 || end == optarg || *end != '\0' || n < 1 || n > MAX_WORKERS ) {
+                    usage( );
+                    return -1;
+                }
+                nr_workers = n;
+                break;
+            }
+            case 'f':
+                if ( std::strcmp( optarg, "json" ) == 0 )
+                    json = true;
+                else if ( std::strcmp( optarg, "csv" ) == 0 )
+                    json = false;
+                else {
+                    usage( );
+                    return -1;
+                }
+                break;
+            case 'c':
+                cache_path = optarg;
+                break;
+            default:
+                usage( );
+                return -1;
+        }
+    }
+    if ( optind >= argc ) {
+        usage( );
+        return -1;
+    }
+
+    scan_cache cache;
+    if ( cache_path && cache_load( cache, cache_path ) != 0 )
+        std::fprintf( stderr, "cannot read cache %s, starting over\n", cache_path );
+
+    work_pool pool( nr_workers );
+    struct scan_state state;
+    state.cache = cache_path ? &cache : NULL;
+    state.workers.resize( pool.workers( ) );
+
+    std::uint64_t failures = 0;
+    for ( int i = optind; i < argc; ++i ) {
+        const std::string root = argv[ i ];
+        // the roots themselves are followed even if they are links
+        struct stat st;
+        if ( stat( root.c_str( ), &st ) != 0 )
+            failures++;
+        else if ( S_ISDIR( st.st_mode ) )
+            pool.push( i, [ &state, root ]( work_pool& p, std::size_t w ) {
+                scan_dir( p, state, w, root );
+            } );
+        else if ( S_ISREG( st.st_mode ) )
+            pool.push( i, [ &state, root ]( work_pool&, std::size_t w ) {
+                scan_file( state, w, root, true );
+            } );
+    }
+    pool.run( );
+
+    std::vector<struct scan_result> files;
+    for ( struct worker_results& w : state.workers ) {
+        failures += w.failures;
+        files.insert( files.end( ), w.files.begin( ), w.files.end( ) );
+    }
+    std::sort( files.begin( ), files.end( ),
+        []( const struct scan_result& a, const struct scan_result& b ) { return a.path < b.path; } );
+
+    struct scan_totals totals = {};
+    totals.failures = failures;
+    for ( const struct scan_result& r : files ) {
+        totals.files++;
+        totals.cached += r.cached;
+        if ( !r.is_elf )
+            continue;
+        totals.elf++;
+        totals.size += r.size;
+        if ( !r.valid ) {
+            totals.invalid++;
+            continue;
+        }
+        totals.alloc_size += r.alloc_size;
+        totals.vsize += r.vsize;
+        totals.file_pages += r.file_pages;
+        totals.anon_pages += r.anon_pages;
+        totals.shared_pages += r.shared_pages;
+        totals.private_pages += r.private_pages;
+        totals.relro_pages += r.relro_pages;
+        totals.tls_size += r.tls_size;
+    }
+
+    if ( json )
+        print_json( files, totals );
+    else print_csv( files, totals );
+
+    if ( cache_path ) {
+        // entries under the scanned roots are replaced by what this run
+        // saw, so deleted files drop out; other roots are kept as they are
+        for ( auto it = cache.begin( ); it != cache.end( ); ) {
+            bool scanned = false;
+            for ( int i = optind; i < argc && !scanned; ++i )
+                scanned = under_root( it->first, argv[ i ] );
+            it = scanned ? cache.erase( it ) : std::next( it );
+        }
+        for ( struct scan_result& r : files ) {
+            r.cached = false;
+            cache[ r.path ] = r;
+        }
+        if ( cache_store( cache, cache_path ) != 0 ) {
+            std::fprintf( stderr, "cannot write cache %s\n", cache_path );
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef _BULK_HPP_
+#define _BULK_HPP_
+
+#include <cstdint>
+#include <string>
+
+// result of the analysis of a single regular file
+struct scan_result {
+    std::string path;
+
+    // identity of the file, the cache entry is valid while it matches
+    std::uint64_t dev;
+    std::uint64_t ino;
+    std::int64_t mtime_sec;
+    std::int64_t mtime_nsec;
+    std::uint64_t size;
+
+    bool is_elf;  /* passed the magic check */
+    bool valid;   /* header tables parsed fine */
+    bool cached;  /* taken from the cache, not analysed in this run */
+    bool is64;
+    bool msb;
+    std::uint16_t type;
+    std::uint16_t machine;
+
+    std::uint64_t alloc_size; /* see elf_alloc_size */
+
+    // see struct elf_footprint
+    std::uint64_t vsize;
+    std::uint64_t file_pages;
+    std::uint64_t anon_pages;
+    std::uint64_t shared_pages;
+    std::uint64_t private_pages;
+    std::uint64_t relro_pages;
+    std::uint64_t tls_size;
+};
+
+/**
+ * Bulk mode of elfdump: walks the given directory trees on a pool of
+ * threads and prints per-file and aggregate results, argv[0] is "-b".
+ **/
+int bulk_main( int argc, char** argv );
+
+#endif // _BULK_HPP_
@@ -0,0 +1,110 @@
+#include "cache.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+// bump whenever the line layout or the meaning of a field changes
+#define CACHE_MAGIC "elfdump-cache 3"
+
+// dev ino mtime_sec mtime_nsec size is_elf valid is64 msb type machine alloc
+// vsize file anon shared private relro tls path
+#define CACHE_LINE_FMT "%" SCNu64 " %" SCNu64 " %" SCNd64 " %" SCNd64 " %" SCNu64 \
+    " %d %d %d %d %d %d %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 \
+    " %" SCNu64 " %" SCNu64 " %" SCNu64 "%n"
+
+int cache_load( scan_cache& cache, const char* path ) {
+    FILE* fp = fopen( path, "r" );
+    if ( !fp )
+        return 0; // nothing cached yet
+
+    char* line = NULL;
+    std::size_t cap = 0;
+    ssize_t len = getline( &line, &cap, fp );
+    if ( len < 0 || std::strcmp( line, CACHE_MAGIC "\n" ) != 0 ) {
+        free( line );
+        fclose( fp );
+        return 0;
+    }
+
+    while ( ( len = getline( &line, &cap, fp ) ) > 0 ) {
+        if ( line[ len - 1 ] == '\n' )
+            line[ --len ] = '\0';
+
+        struct scan_result r;
+        int is_elf, valid, is64, msb, type, machine, path_at = -1;
+        std::sscanf( line, CACHE_LINE_FMT, &r.dev, &r.ino, &r.mtime_sec, &r.mtime_nsec, &r.size,
+            &is_elf, &valid, &is64, &msb, &type, &machine, &r.alloc_size,
+            &r.vsize, &r.file_pages, &r.anon_pages, &r.shared_pages, &r.private_pages,
+            &r.relro_pages, &r.tls_size, &path_at );
+        // a damaged line is simply dropped, the file gets analysed again,
+        // exactly one space separates the path which may start with blanks
+        if ( path_at < 0 || path_at + 1 >= len || line[ path_at ] != ' ' )
+            continue;
+
+        r.path = line + path_at + 1;
+        r.is_elf = is_elf;
+        r.valid = valid;
+        r.cached = true;
+        r.is64 = is64;
+        r.msb = msb;
+        r.type = ( std::uint16_t ) type;
+        r.machine = ( std::uint16_t ) machine;
+        cache[ r.path ] = r;
+    }
+
+    free( line );
+    const bool failed = ferror( fp );
+    fclose( fp );
+    return failed ? -1 : 0;
+}
+
+int cache_store( const scan_cache& cache, const char* path ) {
+    char tmp[ 4096 ];
+    if ( std::snprintf( tmp, sizeof( tmp ), "%s.%ld.tmp", path, ( long ) getpid( ) ) >= ( int ) sizeof( tmp ) )
+        return -1;
+
+    FILE* fp = fopen( tmp, "w" );
+    if ( !fp )
+        return -1;
+
+    std::fputs( CACHE_MAGIC "\n", fp );
+    for ( const auto& entry : cache ) {
+        const struct scan_result& r = entry.second;
+        if ( r.path.find( '\n' ) != std::string::npos )
+            continue; // can't be stored in a line based format
+        std::fprintf( fp, "%" PRIu64 " %" PRIu64 " %" PRId64 " %" PRId64 " %" PRIu64
+            " %d %d %d %d %d %d %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+            " %" PRIu64 " %" PRIu64 " %" PRIu64 " %s\n",
+            r.dev, r.ino, r.mtime_sec, r.mtime_nsec, r.size,
+            r.is_elf, r.valid, r.is64, r.msb, r.type, r.machine, r.alloc_size,
+            r.vsize, r.file_pages, r.anon_pages, r.shared_pages, r.private_pages,
+            r.relro_pages, r.tls_size, r.path.c_str( ) );
+    }
+
+    const bool failed = ferror( fp );
+    if ( fclose( fp ) != 0 || failed || rename( tmp, path ) != 0 ) {
+        unlink( tmp );
+        return -1;
+    }
+    return 0;
+}
+
+bool cache_lookup( const scan_cache& cache, const std::string& path,
+    std::uint64_t dev, std::uint64_t ino, std::int64_t mtime_sec,
+    std::int64_t mtime_nsec, std::uint64_t size, struct scan_result* out ) {
+    const auto it = cache.find( path );
+    if ( it == cache.end( ) )
+        return false;
+
+    const struct scan_result& r = it->second;
+    if ( r.dev != dev || r.ino != ino || r.mtime_sec != mtime_sec
+      || r.mtime_nsec != mtime_nsec || r.size != size )
+        return false;
+
+    *out = r;
+    out->cached = true;
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef _CACHE_HPP_
+#define _CACHE_HPP_
+
+#include <string>
+#include <unordered_map>
+
+#include "bulk.hpp"
+
+// results of the previous runs by path
+typedef std::unordered_map<std::string, struct scan_result> scan_cache;
+
+/**
+ * Loads the cache from path into cache. A missing file or a file of
+ * an other format version leaves the cache empty and is not an error.
+ * Returns 0 on success and -1 if the file could not be read.
+ **/
+int cache_load( scan_cache& cache, const char* path );
+
+/**
+ * Replaces the cache file with the contents of cache, the old file
+ * stays intact if writing fails. Returns 0 on success and -1 on failure.
+ **/
+int cache_store( const scan_cache& cache, const char* path );
+
+/**
+ * Looks up a result for the file at path and copies it to out if the
+ * file has not changed since it was cached.
+ **/
+bool cache_lookup( const scan_cache& cache, const std::string& path,
+    std::uint64_t dev, std::uint64_t ino, std::int64_t mtime_sec,
+    std::int64_t mtime_nsec, std::uint64_t size, struct scan_result* out );
+
+#endif // _CACHE_HPP_
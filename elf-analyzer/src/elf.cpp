@@ -0,0 +1,275 @@
+#include "elf.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// on-disk sizes of the headers for both classes
+#define ELF32_EHDR_SZ	52
+#define ELF64_EHDR_SZ	64
+#define ELF32_PHDR_SZ	32
+#define ELF64_PHDR_SZ	56
+#define ELF32_SHDR_SZ	40
+#define ELF64_SHDR_SZ	64
+
+// fields are assembled byte by byte, so neither the host byte order
+// nor the alignment of the mapping matter
+static std::uint16_t rd16( const std::uint8_t* p, bool msb ) {
+    if ( msb )
+        return ( std::uint16_t ) ( ( p[ 0 ] << 8 ) | p[ 1 ] );
+    return ( std::uint16_t ) ( ( p[ 1 ] << 8 ) | p[ 0 ] );
+}
+
+static std::uint32_t rd32( const std::uint8_t* p, bool msb ) {
+    if ( msb )
+        return ( ( std::uint32_t ) rd16( p, msb ) << 16 ) | rd16( p + 2, msb );
+    return ( ( std::uint32_t ) rd16( p + 2, msb ) << 16 ) | rd16( p, msb );
+}
+
+static std::uint64_t rd64( const std::uint8_t* p, bool msb ) {
+    if ( msb )
+        return ( ( std::uint64_t ) rd32( p, msb ) << 32 ) | rd32( p + 4, msb );
+    return ( ( std::uint64_t ) rd32( p + 4, msb ) << 32 ) | rd32( p, msb );
+}
+
+static bool in_bounds( std::size_t size, std::uint64_t offset, std::uint64_t len ) {
+    return offset <= size && len <= size - offset;
+}
+
+bool elf_is_elf( const void* ident, std::size_t size ) {
+    const std::uint8_t* id = ( const std::uint8_t* ) ident;
+    if ( size < ELF_NIDENT )
+        return false;
+
+    if ( id[ 0 ] != 0x7f     // Magic number
+      || id[ 1 ] != 0x45     // E
+      || id[ 2 ] != 0x4c     // L
+      || id[ 3 ] != 0x46 )   // F
+        return false;
+
+    return ( id[ EI_CLASS ] == ELFCLASS32 || id[ EI_CLASS ] == ELFCLASS64 )
+        && ( id[ EI_DATA ] == ELFDATA2LSB || id[ EI_DATA ] == ELFDATA2MSB );
+}
+
+static void decode_ehdr( const struct elf_file* elf, const std::uint8_t* p, struct elf_hdr* out ) {
+    const bool msb = elf->msb;
+    std::memcpy( out->e_ident, p, ELF_NIDENT );
+    out->e_type = rd16( p + 16, msb );
+    out->e_machine = rd16( p + 18, msb );
+    out->e_version = rd32( p + 20, msb );
+    if ( elf->is64 ) {
+        out->e_entry = rd64( p + 24, msb );
+        out->e_phoff = rd64( p + 32, msb );
+        out->e_shoff = rd64( p + 40, msb );
+        p += 48;
+    } else {
+        out->e_entry = rd32( p + 24, msb );
+        out->e_phoff = rd32( p + 28, msb );
+        out->e_shoff = rd32( p + 32, msb );
+        p += 36;
+    }
+    // the tail of the header is laid out the same way for both classes
+    out->e_flags = rd32( p, msb );
+    out->e_ehsize = rd16( p + 4, msb );
+    out->e_phentsize = rd16( p + 6, msb );
+    out->e_phnum = rd16( p + 8, msb );
+    out->e_shentsize = rd16( p + 10, msb );
+    out->e_shnum = rd16( p + 12, msb );
+    out->e_shstrndx = rd16( p + 14, msb );
+}
+
+static void decode_phdr( const struct elf_file* elf, const std::uint8_t* p, struct elf_phdr* out ) {
+    const bool msb = elf->msb;
+    out->p_type = rd32( p, msb );
+    if ( elf->is64 ) {
+        out->p_flags = rd32( p + 4, msb );
+        out->p_offset = rd64( p + 8, msb );
+        out->p_vaddr = rd64( p + 16, msb );
+        out->p_paddr = rd64( p + 24, msb );
+        out->p_filesz = rd64( p + 32, msb );
+        out->p_memsz = rd64( p + 40, msb );
+        out->p_align = rd64( p + 48, msb );
+    } else {
+        out->p_offset = rd32( p + 4, msb );
+        out->p_vaddr = rd32( p + 8, msb );
+        out->p_paddr = rd32( p + 12, msb );
+        out->p_filesz = rd32( p + 16, msb );
+        out->p_memsz = rd32( p + 20, msb );
+        out->p_flags = rd32( p + 24, msb );
+        out->p_align = rd32( p + 28, msb );
+    }
+}
+
+static void decode_shdr( const struct elf_file* elf, const std::uint8_t* p, struct elf_shdr* out ) {
+    const bool msb = elf->msb;
+    out->sh_name = rd32( p, msb );
+    out->sh_type = rd32( p + 4, msb );
+    if ( elf->is64 ) {
+        out->sh_flags = rd64( p + 8, msb );
+        out->sh_addr = rd64( p + 16, msb );
+        out->sh_offset = rd64( p + 24, msb );
+        out->sh_size = rd64( p + 32, msb );
+        out->sh_link = rd32( p + 40, msb );
+        out->sh_info = rd32( p + 44, msb );
+        out->sh_addralign = rd64( p + 48, msb );
+        out->sh_entsize = rd64( p + 56, msb );
+    } else {
+        out->sh_flags = rd32( p + 8, msb );
+        out->sh_addr = rd32( p + 12, msb );
+        out->sh_offset = rd32( p + 16, msb );
+        out->sh_size = rd32( p + 20, msb );
+        out->sh_link = rd32( p + 24, msb );
+        out->sh_info = rd32( p + 28, msb );
+        out->sh_addralign = rd32( p + 32, msb );
+        out->sh_entsize = rd32( p + 36, msb );
+    }
+}
+
+int elf_attach( struct elf_file* elf, const void* data, std::size_t size ) {
+    std::memset( elf, 0, sizeof( struct elf_file ) );
+    elf->base = ( const std::uint8_t* ) data;
+    elf->size = size;
+
+    if ( !elf_is_elf( data, size ) )
+        return -1;
+
+    elf->is64 = elf->base[ EI_CLASS ] == ELFCLASS64;
+    elf->msb = elf->base[ EI_DATA ] == ELFDATA2MSB;
+
+    // read file header
+    if ( size < ( elf->is64 ? ELF64_EHDR_SZ : ELF32_EHDR_SZ ) )
+        return -1;
+    decode_ehdr( elf, elf->base, &elf->hdr );
+
+    const std::size_t phdr_sz = elf->is64 ? ELF64_PHDR_SZ : ELF32_PHDR_SZ;
+    const std::size_t shdr_sz = elf->is64 ? ELF64_SHDR_SZ : ELF32_SHDR_SZ;
+
+    elf->phnum = elf->hdr.e_phnum;
+    elf->shnum = elf->hdr.e_shnum;
+    elf->shstrndx = elf->hdr.e_shstrndx;
+
+    // a stripped or truncated section table leaves the image loadable,
+    // so it is dropped rather than failing the whole file
+    bool have_sh0 = false;
+    struct elf_shdr sh0;
+    if ( elf->hdr.e_shoff != 0 && elf->hdr.e_shentsize >= shdr_sz
+      && in_bounds( size, elf->hdr.e_shoff, elf->hdr.e_shentsize ) ) {
+        decode_shdr( elf, elf->base + elf->hdr.e_shoff, &sh0 );
+        have_sh0 = true;
+    }
+
+    // resolve extended numbering through section header 0
+    if ( elf->hdr.e_phnum == PN_XNUM ) {
+        if ( !have_sh0 )
+            return -1;
+        elf->phnum = sh0.sh_info;
+    }
+    if ( have_sh0 && elf->hdr.e_shnum == 0 )
+        elf->shnum = sh0.sh_size;
+    if ( have_sh0 && elf->hdr.e_shstrndx == SHN_XINDEX )
+        elf->shstrndx = sh0.sh_link;
+
+    // entries are walked with the on-disk stride, which may be wider
+    // than the structure we know about but never narrower
+    if ( elf->phnum > 0 )
+        if ( elf->hdr.e_phentsize < phdr_sz
+          || elf->phnum > size / elf->hdr.e_phentsize
+          || !in_bounds( size, elf->hdr.e_phoff, ( std::uint64_t ) elf->phnum * elf->hdr.e_phentsize ) )
+            return -1;
+
+    if ( !have_sh0 || elf->shnum > size / elf->hdr.e_shentsize
+      || !in_bounds( size, elf->hdr.e_shoff, ( std::uint64_t ) elf->shnum * elf->hdr.e_shentsize ) ) {
+        elf->shnum = 0;
+        elf->shstrndx = SHN_UNDEF;
+    }
+
+    return 0;
+}
+
+int elf_fdopen( struct elf_file* elf, int fd ) {
+    std::memset( elf, 0, sizeof( struct elf_file ) );
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) || st.st_size == 0 )
+        return -1;
+
+    const std::size_t size = ( std::size_t ) st.st_size;
+    void* data = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( data == MAP_FAILED )
+        return -1;
+
+    if ( elf_attach( elf, data, size ) != 0 ) {
+        munmap( data, size );
+        std::memset( elf, 0, sizeof( struct elf_file ) );
+        return -1;
+    }
+    elf->mapped = true;
+    return 0;
+}
+
+int elf_open( struct elf_file* elf, const char* path ) {
+    std::memset( elf, 0, sizeof( struct elf_file ) );
+
+    const int fd = open( path, O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 )
+        return -1;
+
+    const int ret = elf_fdopen( elf, fd );
+    close( fd ); // the mapping keeps its own reference to the file
+    return ret;
+}
+
+void elf_close( struct elf_file* elf ) {
+    if ( elf->mapped )
+        munmap( ( void* ) elf->base, elf->size );
+    std::memset( elf, 0, sizeof( struct elf_file ) );
+}
+
+const void* elf_bytes( const struct elf_file* elf, std::uint64_t offset, std::uint64_t size ) {
+    if ( !in_bounds( elf->size, offset, size ) )
+        return NULL;
+    return elf->base + offset;
+}
+
+int elf_phdr_at( const struct elf_file* elf, std::size_t i, struct elf_phdr* out ) {
+    if ( i >= elf->phnum )
+        return -1;
+    decode_phdr( elf, elf->base + elf->hdr.e_phoff + i * elf->hdr.e_phentsize, out );
+    return 0;
+}
+
+int elf_shdr_at( const struct elf_file* elf, std::size_t i, struct elf_shdr* out ) {
+    if ( i >= elf->shnum )
+        return -1;
+    decode_shdr( elf, elf->base + elf->hdr.e_shoff + i * elf->hdr.e_shentsize, out );
+    return 0;
+}
+
+const char* elf_section_name( const struct elf_file* elf, const struct elf_shdr* shdr ) {
+    struct elf_shdr strtab;
+    if ( elf->shstrndx == SHN_UNDEF || elf_shdr_at( elf, elf->shstrndx, &strtab ) != 0 )
+        return "";
+    if ( strtab.sh_type == SHT_NOBITS || shdr->sh_name >= strtab.sh_size )
+        return "";
+
+    const char* names = ( const char* ) elf_bytes( elf, strtab.sh_offset, strtab.sh_size );
+    if ( names == NULL )
+        return "";
+
+    // the name has to be terminated inside the string table
+    const std::size_t left = strtab.sh_size - shdr->sh_name;
+    if ( std::memchr( names + shdr->sh_name, '\0', left ) == NULL )
+        return "";
+    return names + shdr->sh_name;
+}
+
+std::uint64_t elf_alloc_size( const struct elf_file* elf ) {
+    std::uint64_t alloc_size = 0;
+    struct elf_shdr shdr;
+    for ( std::size_t i = 0; elf_shdr_at( elf, i, &shdr ) == 0; ++i )
+        if ( shdr.sh_flags & SHF_ALLOC )
+            alloc_size += shdr.sh_size;
+    return alloc_size;
+}
@@ -0,0 +1,155 @@
+#ifndef _ELF_HPP_
+#define _ELF_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+
+#define ELF_NIDENT	16
+
+// indices into e_ident
+#define EI_CLASS	4
+#define EI_DATA		5
+
+#define ELFCLASS32	1
+#define ELFCLASS64	2
+
+#define ELFDATA2LSB	1
+#define ELFDATA2MSB	2
+
+// program header-ы такого типа нужно загрузить в
+// память при загрузке приложения
+#define PT_LOAD		1
+#define PT_TLS		7
+#define PT_GNU_RELRO	0x6474e552
+
+#define PF_X		1
+#define PF_W		2
+#define PF_R		4
+
+#define SHT_NOBITS	8
+#define SHF_ALLOC	2
+
+// extended numbering escapes, real values live in section header 0
+#define PN_XNUM		0xffff
+#define SHN_UNDEF	0
+#define SHN_XINDEX	0xffff
+
+// структура заголовка ELF файла
+struct elf_hdr {
+	std::uint8_t e_ident[ELF_NIDENT];
+	std::uint16_t e_type;
+	std::uint16_t e_machine;
+	std::uint32_t e_version;
+	std::uint64_t e_entry;
+	std::uint64_t e_phoff;
+	std::uint64_t e_shoff;
+	std::uint32_t e_flags;
+	std::uint16_t e_ehsize;
+	std::uint16_t e_phentsize;
+	std::uint16_t e_phnum;
+	std::uint16_t e_shentsize;
+	std::uint16_t e_shnum;
+	std::uint16_t e_shstrndx;
+} __attribute__((packed));
+
+// структура записи в таблице program header-ов
+struct elf_phdr {
+	std::uint32_t p_type;
+	std::uint32_t p_flags;
+	std::uint64_t p_offset;
+	std::uint64_t p_vaddr;
+	std::uint64_t p_paddr;
+	std::uint64_t p_filesz;
+	std::uint64_t p_memsz;
+	std::uint64_t p_align;
+} __attribute__((packed));
+
+// структура записи в таблице section header-ов
+struct elf_shdr {
+	std::uint32_t sh_name;
+	std::uint32_t sh_type;
+	std::uint64_t sh_flags;
+	std::uint64_t sh_addr;
+	std::uint64_t sh_offset;
+	std::uint64_t sh_size;
+	std::uint32_t sh_link;
+	std::uint32_t sh_info;
+	std::uint64_t sh_addralign;
+	std::uint64_t sh_entsize;
+} __attribute__((packed));
+
+/**
+ * Read-only view of an ELF image. The file is mapped once and the
+ * header tables are never copied: entries are decoded straight from
+ * the mapping into the 64-bit structures above, whatever the class
+ * and byte order of the image are.
+ *
+ * hdr holds the file header as stored, use phnum, shnum and shstrndx
+ * instead of its e_phnum, e_shnum and e_shstrndx: they are resolved
+ * through extended numbering, and shnum is 0 if the section header
+ * table is missing or unusable.
+ **/
+struct elf_file {
+    const std::uint8_t* base;
+    std::size_t size;
+    bool mapped; /* base came from mmap and is unmapped by elf_close */
+    bool is64;
+    bool msb;
+    std::size_t phnum;
+    std::size_t shnum;
+    std::size_t shstrndx;
+    struct elf_hdr hdr;
+};
+
+/**
+ * Checks for the ELF magic and a known class and data encoding,
+ * size is the number of bytes available at ident.
+ **/
+bool elf_is_elf( const void* ident, std::size_t size );
+
+/**
+ * Maps the file at path and validates its header and header tables.
+ * Returns 0 on success and -1 on failure, in the latter case nothing
+ * has to be released.
+ **/
+int elf_open( struct elf_file* elf, const char* path );
+
+/**
+ * Same as elf_open but over an already opened file, fd stays owned
+ * by the caller and may be closed right after the call.
+ **/
+int elf_fdopen( struct elf_file* elf, int fd );
+
+/**
+ * Same as elf_open but over a caller-owned buffer that has to outlive elf.
+ **/
+int elf_attach( struct elf_file* elf, const void* data, std::size_t size );
+
+void elf_close( struct elf_file* elf );
+
+/**
+ * Bounds-checked pointer into the image, NULL if [offset; offset + size)
+ * does not fit the file.
+ **/
+const void* elf_bytes( const struct elf_file* elf, std::uint64_t offset, std::uint64_t size );
+
+/**
+ * Decode the i-th program/section header into out. Return 0 on success
+ * and -1 if i is out of range.
+ **/
+int elf_phdr_at( const struct elf_file* elf, std::size_t i, struct elf_phdr* out );
+int elf_shdr_at( const struct elf_file* elf, std::size_t i, struct elf_shdr* out );
+
+/**
+ * Name of the section from the section header string table, or an
+ * empty string if it can't be resolved.
+ **/
+const char* elf_section_name( const struct elf_file* elf, const struct elf_shdr* shdr );
+
+/**
+ * Sum of sh_size of all SHF_ALLOC sections.
+ **/
+std::uint64_t elf_alloc_size( const struct elf_file* elf );
+
+#endif // _ELF_HPP_
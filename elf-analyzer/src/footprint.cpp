@@ -0,0 +1,157 @@
+#include "footprint.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+enum page_kind {
+    PAGE_FILE_SHARED,
+    PAGE_FILE_PRIVATE,
+    PAGE_ANON
+};
+
+// page aligned range of the address space [start; end)
+struct page_range {
+    std::uint64_t start;
+    std::uint64_t end;
+    enum page_kind kind;
+};
+
+static std::uint64_t page_down( std::uint64_t addr, std::uint64_t page_size ) {
+    return addr & ~( page_size - 1 );
+}
+
+static std::uint64_t page_up( std::uint64_t addr, std::uint64_t page_size ) {
+    return page_down( addr + page_size - 1, page_size );
+}
+
+static bool is_pow2( std::uint64_t x ) {
+    return x != 0 && ( x & ( x - 1 ) ) == 0;
+}
+
+// maps r over the ranges like mmap with MAP_FIXED would do: whatever
+// was mapped at these pages before is replaced
+static void paint( std::vector<struct page_range>& ranges, struct page_range r ) {
+    if ( r.start >= r.end )
+        return;
+
+    std::vector<struct page_range> out;
+    for ( const struct page_range& old : ranges ) {
+        if ( old.end <= r.start || old.start >= r.end ) {
+            out.push_back( old );
+            continue;
+        }
+        if ( old.start < r.start )
+            out.push_back( ( struct page_range ) { old.start, r.start, old.kind } );
+        if ( old.end > r.end )
+            out.push_back( ( struct page_range ) { r.end, old.end, old.kind } );
+    }
+    out.push_back( r );
+    ranges.swap( out );
+}
+
+// private pages of [start; end)
+static std::uint64_t count_private( const std::vector<struct page_range>& ranges,
+    std::uint64_t start, std::uint64_t end, std::uint64_t page_size ) {
+    std::uint64_t pages = 0;
+    for ( const struct page_range& r : ranges ) {
+        if ( r.kind == PAGE_FILE_SHARED )
+            continue;
+        const std::uint64_t lo = std::max( start, r.start );
+        const std::uint64_t hi = std::min( end, r.end );
+        if ( lo < hi )
+            pages += ( hi - lo ) / page_size;
+    }
+    return pages;
+}
+
+static int map_segment( std::vector<struct page_range>& ranges, const struct elf_phdr& phdr, std::uint64_t page_size ) {
+    if ( phdr.p_memsz == 0 )
+        return 0;
+    if ( phdr.p_filesz > phdr.p_memsz || phdr.p_vaddr + phdr.p_memsz < phdr.p_vaddr
+      || phdr.p_vaddr + phdr.p_memsz > UINT64_MAX - page_size )
+        return -1;
+    // the ABI wants a power of two with p_vaddr congruent to p_offset
+    if ( phdr.p_align > 1 && ( !is_pow2( phdr.p_align )
+      || ( phdr.p_vaddr - phdr.p_offset ) % phdr.p_align != 0 ) )
+        return -1;
+
+    const bool writable = phdr.p_flags & PF_W;
+    const std::uint64_t start = page_down( phdr.p_vaddr, page_size );
+    const std::uint64_t file_end = phdr.p_vaddr + phdr.p_filesz;
+    const std::uint64_t mem_end = page_up( phdr.p_vaddr + phdr.p_memsz, page_size );
+
+    // with p_align below the page size the file data may not be
+    // mappable at all, then the loader has to read it into anonymous memory
+    if ( ( phdr.p_vaddr - phdr.p_offset ) % page_size != 0 ) {
+        paint( ranges, ( struct page_range ) { start, mem_end, PAGE_ANON } );
+        return 0;
+    }
+
+    std::uint64_t anon_start = start;
+    if ( phdr.p_filesz > 0 ) {
+        const std::uint64_t full_end = page_down( file_end, page_size );
+        paint( ranges, ( struct page_range ) { start, full_end,
+            writable ? PAGE_FILE_PRIVATE : PAGE_FILE_SHARED } );
+        anon_start = full_end;
+
+        // the last file page is still file-backed, but the loader clears
+        // its tail when BSS follows and so makes a private copy of it
+        if ( file_end != full_end ) {
+            const bool dirty = writable || phdr.p_memsz > phdr.p_filesz;
+            paint( ranges, ( struct page_range ) { full_end, full_end + page_size,
+                dirty ? PAGE_FILE_PRIVATE : PAGE_FILE_SHARED } );
+            anon_start = full_end + page_size;
+        }
+    }
+    paint( ranges, ( struct page_range ) { anon_start, mem_end, PAGE_ANON } );
+    return 0;
+}
+
+int elf_footprint( const struct elf_file* elf, std::uint64_t page_size, struct elf_footprint* fp ) {
+    std::memset( fp, 0, sizeof( struct elf_footprint ) );
+    if ( page_size == 0 )
+        page_size = sysconf( _SC_PAGESIZE );
+    if ( !is_pow2( page_size ) )
+        return -1;
+    fp->page_size = page_size;
+
+    std::vector<struct page_range> ranges;
+    struct elf_phdr phdr;
+    for ( std::size_t i = 0; elf_phdr_at( elf, i, &phdr ) == 0; ++i ) {
+        if ( phdr.p_type == PT_LOAD && map_segment( ranges, phdr, page_size ) != 0 )
+            return -1;
+        // every thread gets its own copy of the TLS image
+        if ( phdr.p_type == PT_TLS )
+            fp->tls_size = phdr.p_align > 1
+                ? ( phdr.p_memsz + phdr.p_align - 1 ) / phdr.p_align * phdr.p_align
+                : phdr.p_memsz;
+    }
+    if ( ranges.empty( ) )
+        return 0;
+
+    std::uint64_t lo = UINT64_MAX, hi = 0;
+    for ( const struct page_range& r : ranges ) {
+        const std::uint64_t pages = ( r.end - r.start ) / page_size;
+        fp->vsize += r.end - r.start;
+        if ( r.kind == PAGE_ANON )
+            fp->anon_pages += pages;
+        else fp->file_pages += pages;
+
+        if ( r.kind == PAGE_FILE_SHARED )
+            fp->shared_pages += pages;
+        else fp->private_pages += pages;
+
+        lo = std::min( lo, r.start );
+        hi = std::max( hi, r.end );
+    }
+    fp->span = hi - lo;
+
+    // the loader mprotects RELRO rounding its end down
+    for ( std::size_t i = 0; elf_phdr_at( elf, i, &phdr ) == 0; ++i )
+        if ( phdr.p_type == PT_GNU_RELRO )
+            fp->relro_pages += count_private( ranges, page_down( phdr.p_vaddr, page_size ),
+                page_down( phdr.p_vaddr + phdr.p_memsz, page_size ), page_size );
+    return 0;
+}
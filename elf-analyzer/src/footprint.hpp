@@ -0,0 +1,41 @@
+#ifndef _FOOTPRINT_HPP_
+#define _FOOTPRINT_HPP_
+
+#include <cstdint>
+
+#include "elf.hpp"
+
+/**
+ * Memory an ELF image costs once it is loaded, computed from the page
+ * ranges the PT_LOAD segments are mapped to. Segments are mapped in
+ * order like the loader does, so a page shared by two segments counts
+ * once and takes the attributes of the later one.
+ *
+ * Page counts below are in pages of page_size bytes:
+ *  - file_pages are backed by the file, anon_pages are the BSS pages
+ *    past the end of the file data;
+ *  - shared_pages are read-only file pages, the page cache shares them
+ *    among all processes running the image; private_pages are the rest,
+ *    written pages of writable segments become copy-on-write copies.
+ *  - relro_pages are private pages made read-only after relocation.
+ **/
+struct elf_footprint {
+    std::uint64_t page_size;
+    std::uint64_t span;   /* bytes of address space reserved, with holes */
+    std::uint64_t vsize;  /* bytes actually mapped */
+    std::uint64_t file_pages;
+    std::uint64_t anon_pages;
+    std::uint64_t shared_pages;
+    std::uint64_t private_pages;
+    std::uint64_t relro_pages;
+    std::uint64_t tls_size; /* bytes of the TLS block of every thread */
+};
+
+/**
+ * Computes the footprint of elf for the given page size, 0 means the
+ * page size of the host. Returns 0 on success and -1 if the program
+ * headers are inconsistent.
+ **/
+int elf_footprint( const struct elf_file* elf, std::uint64_t page_size, struct elf_footprint* fp );
+
+#endif // _FOOTPRINT_HPP_
@@ -0,0 +1,271 @@
+#include "loader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#include "elf.hpp"
+#include "footprint.hpp"
+
+// no image needs more address space than a 47-bit user half offers
+#define MAX_SPAN	( 1ULL << 47 )
+
+// bits of a /proc/self/pagemap entry
+#define PM_PRESENT	( 1ULL << 63 )
+#define PM_SWAPPED	( 1ULL << 62 )
+
+// pages looked up per pagemap read or mincore call
+#define RESIDENT_CHUNK	512
+
+// part of the span a segment ended up at, used to find readable pages
+struct seg_range {
+    std::uintptr_t start;
+    std::uintptr_t end;
+    bool readable;
+};
+
+static std::uint64_t page_down( std::uint64_t addr, std::uint64_t page_size ) {
+    return addr & ~( page_size - 1 );
+}
+
+static std::uint64_t page_up( std::uint64_t addr, std::uint64_t page_size ) {
+    return page_down( addr + page_size - 1, page_size );
+}
+
+static std::uint64_t pow2_up( std::uint64_t x ) {
+    std::uint64_t p = 1;
+    while ( p < x )
+        p <<= 1;
+    return p;
+}
+
+static int prot_of( std::uint32_t flags ) {
+    return ( ( flags & PF_R ) ? PROT_READ : 0 )
+         | ( ( flags & PF_W ) ? PROT_WRITE : 0 )
+         | ( ( flags & PF_X ) ? PROT_EXEC : 0 );
+}
+
+// resident pages of [start; start + len) of our own address space,
+// fd is /proc/self/pagemap or -1 if it can't be read
+static std::uint64_t count_range( int fd, std::uintptr_t start, std::uint64_t len, std::uint64_t page_size ) {
+    std::uint64_t resident = 0;
+    for ( std::uint64_t done = 0; done < len; ) {
+        const std::size_t pages = std::min( ( len - done ) / page_size, ( std::uint64_t ) RESIDENT_CHUNK );
+        const std::uintptr_t addr = start + done;
+        done += pages * page_size;
+
+        // pagemap tells whether the page is mapped into this process, which
+        // is what we want, mincore would count any page in the page cache
+        std::uint64_t entries[ RESIDENT_CHUNK ];
+        const std::size_t want = pages * sizeof( std::uint64_t );
+        if ( fd >= 0 && pread( fd, entries, want, ( addr / page_size ) * sizeof( std::uint64_t ) ) == ( ssize_t ) want ) {
+            for ( std::size_t i = 0; i < pages; ++i )
+                if ( entries[ i ] & ( PM_PRESENT | PM_SWAPPED ) )
+                    resident++;
+            continue;
+        }
+
+        unsigned char vec[ RESIDENT_CHUNK ];
+        if ( mincore( ( void* ) addr, pages * page_size, vec ) != 0 )
+            continue;
+        for ( std::size_t i = 0; i < pages; ++i )
+            resident += vec[ i ] & 1;
+    }
+    return resident;
+}
+
+// resident pages of the mapped ranges, holes of the span are never read
+static std::uint64_t count_resident( const std::vector<struct seg_range>& ranges, std::uint64_t page_size ) {
+    const int fd = open( "/proc/self/pagemap", O_RDONLY | O_CLOEXEC );
+    std::uint64_t resident = 0;
+    for ( const struct seg_range& r : ranges )
+        resident += count_range( fd, r.start, r.end - r.start, page_size );
+    if ( fd >= 0 )
+        close( fd );
+    return resident;
+}
+
+// the mapped parts of the span in address order, overlapping and
+// adjacent segments merged so that no page is counted twice
+static std::vector<struct seg_range> merge_ranges( std::vector<struct seg_range> segs ) {
+    std::sort( segs.begin( ), segs.end( ), []( const struct seg_range& a, const struct seg_range& b ) {
+        return a.start < b.start;
+    } );
+    std::vector<struct seg_range> ranges;
+    for ( const struct seg_range& r : segs ) {
+        if ( !ranges.empty( ) && r.start <= ranges.back( ).end )
+            ranges.back( ).end = std::max( ranges.back( ).end, r.end );
+        else ranges.push_back( r );
+    }
+    return ranges;
+}
+
+static int load_segment( int fd, const struct elf_phdr& phdr, std::uintptr_t bias, std::uint64_t page_size ) {
+    const int prot = prot_of( phdr.p_flags );
+    const std::uintptr_t start = page_down( phdr.p_vaddr, page_size ) + bias;
+    const std::uintptr_t file_end = phdr.p_vaddr + phdr.p_filesz + bias;
+    const std::uintptr_t mem_end = page_up( phdr.p_vaddr + phdr.p_memsz, page_size ) + bias;
+
+    // data that can't be mapped at its address has to be read in
+    if ( ( phdr.p_vaddr - phdr.p_offset ) % page_size != 0 ) {
+        if ( mmap( ( void* ) start, mem_end - start, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS, -1, 0 ) == MAP_FAILED )
+            return -1;
+        if ( pread( fd, ( void* ) ( phdr.p_vaddr + bias ), phdr.p_filesz, phdr.p_offset ) != ( ssize_t ) phdr.p_filesz )
+            return -1;
+        return mprotect( ( void* ) start, mem_end - start, prot );
+    }
+
+    std::uintptr_t anon_start = start;
+    if ( phdr.p_filesz > 0 ) {
+        // no MAP_POPULATE: pages fault in from the file on first access
+        const std::uintptr_t map_end = page_up( file_end, page_size );
+        if ( mmap( ( void* ) start, map_end - start, prot, MAP_PRIVATE | MAP_FIXED,
+                fd, page_down( phdr.p_offset, page_size ) ) == MAP_FAILED )
+            return -1;
+        anon_start = map_end;
+
+        // the rest of the last file page belongs to BSS and must read as zeroes
+        if ( phdr.p_memsz > phdr.p_filesz && file_end != map_end ) {
+            void* last = ( void* ) page_down( file_end, page_size );
+            if ( !( prot & PROT_WRITE ) && mprotect( last, page_size, prot | PROT_WRITE ) != 0 )
+                return -1;
+            std::memset( ( void* ) file_end, 0, map_end - file_end );
+            if ( !( prot & PROT_WRITE ) && mprotect( last, page_size, prot ) != 0 )
+                return -1;
+        }
+    }
+
+    // anonymous pages are zero-filled by the kernel, also on first access
+    if ( anon_start < mem_end )
+        if ( mmap( ( void* ) anon_start, mem_end - anon_start, prot,
+                MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS, -1, 0 ) == MAP_FAILED )
+            return -1;
+    return 0;
+}
+
+static bool is_readable( const std::vector<struct seg_range>& segs, std::uintptr_t addr ) {
+    // segments are mapped in order, so the last one covering addr wins
+    for ( std::size_t i = segs.size( ); i > 0; --i )
+        if ( addr >= segs[ i - 1 ].start && addr < segs[ i - 1 ].end )
+            return segs[ i - 1 ].readable;
+    return false;
+}
+
+static int load_image( int fd, const struct elf_file* elf, std::size_t touch_pages,
+    const struct elf_footprint& fp, struct elf_load_report* rep ) {
+    const std::uint64_t page_size = fp.page_size;
+
+    std::uint64_t lo = UINT64_MAX, hi = 0, align = page_size;
+    struct elf_phdr phdr;
+    for ( std::size_t i = 0; elf_phdr_at( elf, i, &phdr ) == 0; ++i ) {
+        if ( phdr.p_type != PT_LOAD || phdr.p_memsz == 0 )
+            continue;
+        // a mapping past the end of the file would SIGBUS on access
+        if ( elf_bytes( elf, phdr.p_offset, phdr.p_filesz ) == NULL )
+            return -1;
+        lo = std::min( lo, page_down( phdr.p_vaddr, page_size ) );
+        hi = std::max( hi, page_up( phdr.p_vaddr + phdr.p_memsz, page_size ) );
+        align = std::max( align, phdr.p_align );
+    }
+
+    // reserve the whole span up front so the segments keep their relative
+    // placement, the image is always moved, even ET_EXEC, since nothing
+    // is ever run from it; over-reserve to honour the largest p_align
+    const std::uint64_t span = hi - lo;
+    if ( span > MAX_SPAN )
+        return -1;
+    // an alignment beyond the image size only moves it around, so it is
+    // capped instead of trusted; this also bounds extra by span
+    align = std::min( align, std::max( pow2_up( span ), page_size ) );
+    const std::uint64_t extra = align - page_size;
+    if ( span > MAX_SPAN - extra || span + extra > SIZE_MAX )
+        return -1;
+    void* reserved = mmap( NULL, span + extra, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    if ( reserved == MAP_FAILED )
+        return -1;
+
+    const std::uintptr_t res = ( std::uintptr_t ) reserved;
+    const std::uintptr_t base = ( res + align - 1 ) & ~( ( std::uintptr_t ) align - 1 );
+    if ( base > res )
+        munmap( reserved, base - res );
+    if ( res + span + extra > base + span )
+        munmap( ( void* ) ( base + span ), res + span + extra - ( base + span ) );
+
+    const std::uintptr_t bias = base - lo;
+    std::vector<struct seg_range> segs;
+    for ( std::size_t i = 0; elf_phdr_at( elf, i, &phdr ) == 0; ++i ) {
+        if ( phdr.p_type != PT_LOAD || phdr.p_memsz == 0 )
+            continue;
+        if ( load_segment( fd, phdr, bias, page_size ) != 0 ) {
+            munmap( ( void* ) base, span );
+            return -1;
+        }
+        segs.push_back( ( struct seg_range ) { ( std::uintptr_t ) page_down( phdr.p_vaddr, page_size ) + bias,
+            ( std::uintptr_t ) page_up( phdr.p_vaddr + phdr.p_memsz, page_size ) + bias,
+            ( phdr.p_flags & PF_R ) != 0 } );
+    }
+
+    rep->page_size = page_size;
+    rep->span = span;
+    rep->mapped_pages = fp.vsize / page_size;
+    const std::vector<struct seg_range> ranges = merge_ranges( segs );
+    rep->resident_mapped = count_resident( ranges, page_size );
+
+    std::uintptr_t addr = base;
+    const std::uintptr_t entry = elf->hdr.e_entry + bias;
+    if ( elf->hdr.e_entry != 0 && entry >= base && entry < base + span )
+        addr = page_down( entry, page_size );
+
+    // walk the mapped ranges from addr on, jumping over the holes between them
+    for ( const struct seg_range& r : ranges ) {
+        if ( rep->touched_pages >= touch_pages )
+            break;
+        if ( r.end <= addr )
+            continue;
+        for ( addr = std::max( addr, r.start ); addr < r.end && rep->touched_pages < touch_pages; addr += page_size ) {
+            if ( !is_readable( segs, addr ) )
+                continue;
+            ( void ) *( volatile const std::uint8_t* ) addr;
+            rep->touched_pages++;
+        }
+    }
+    // file pages may be more than touched: the kernel maps pages around
+    // the faulting one if they are in the page cache already
+    rep->resident_touched = count_resident( ranges, page_size );
+
+    munmap( ( void* ) base, span );
+    return 0;
+}
+
+int elf_load_file( const struct elf_file* elf, int fd, std::size_t touch_pages, struct elf_load_report* rep ) {
+    std::memset( rep, 0, sizeof( struct elf_load_report ) );
+
+    // the footprint validates the program headers for us
+    struct elf_footprint fp;
+    if ( elf_footprint( elf, 0, &fp ) != 0 || fp.vsize == 0 )
+        return -1;
+    return load_image( fd, elf, touch_pages, fp, rep );
+}
+
+int elf_load( const char* path, std::size_t touch_pages, struct elf_load_report* rep ) {
+    std::memset( rep, 0, sizeof( struct elf_load_report ) );
+
+    const int fd = open( path, O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 )
+        return -1;
+
+    struct elf_file elf;
+    if ( elf_fdopen( &elf, fd ) != 0 ) {
+        close( fd );
+        return -1;
+    }
+
+    const int ret = elf_load_file( &elf, fd, touch_pages, rep );
+    elf_close( &elf );
+    close( fd );
+    return ret;
+}
@@ -0,0 +1,41 @@
+#ifndef _LOADER_HPP_
+#define _LOADER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "elf.hpp"
+
+// what loading an image actually cost, page counts are in page_size pages
+struct elf_load_report {
+    std::uint64_t page_size;
+    std::uint64_t span;             /* bytes of address space reserved */
+    std::uint64_t mapped_pages;     /* pages covered by the segment mappings */
+    std::uint64_t touched_pages;    /* pages read around the entry point */
+    std::uint64_t resident_mapped;  /* resident right after mapping */
+    std::uint64_t resident_touched; /* resident after touching the entry region */
+};
+
+/**
+ * Loads the PT_LOAD segments of the ELF file at path into a freshly
+ * reserved span of the address space, without relocating or running
+ * anything, and measures how many of its pages are resident.
+ *
+ * File-backed parts are mapped lazily and fault in only when touched,
+ * BSS is zero-filled. After mapping, touch_pages readable pages starting
+ * at the page of the entry point (or of the first segment if there is
+ * no entry point) are read once.
+ *
+ * Everything is unmapped again before returning. Returns 0 on success
+ * and -1 on failure.
+ **/
+int elf_load( const char* path, std::size_t touch_pages, struct elf_load_report* rep );
+
+/**
+ * Same as elf_load for an image that is already open, fd is the
+ * descriptor elf was opened from and is used to map the segments.
+ * Neither elf nor fd is closed.
+ **/
+int elf_load_file( const struct elf_file* elf, int fd, std::size_t touch_pages, struct elf_load_report* rep );
+
+#endif // _LOADER_HPP_
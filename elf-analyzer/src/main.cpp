@@ -1,95 +1,150 @@
 #include <iostream>
 #include <cstdint>
-
-
-#define ELF_NIDENT	16
-
-// program header-ы такого типа нужно загрузить в
-// память при загрузке приложения
-#define PT_LOAD		1
-
-// структура заголовка ELF файла
-struct elf_hdr {
-	std::uint8_t e_ident[ELF_NIDENT];
-	std::uint16_t e_type;
-	std::uint16_t e_machine;
-	std::uint32_t e_version;
-	std::uint64_t e_entry;
-	std::uint64_t e_phoff;
-	std::uint64_t e_shoff;
-	std::uint32_t e_flags;
-	std::uint16_t e_ehsize;
-	std::uint16_t e_phentsize;
-	std::uint16_t e_phnum;
-	std::uint16_t e_shentsize;
-	std::uint16_t e_shnum;
-	std::uint16_t e_shstrndx;
-} __attribute__((packed));
-
-// структура записи в таблице program header-ов
-struct elf_phdr {
-	std::uint32_t p_type;
-	std::uint32_t p_flags;
-	std::uint64_t p_offset;
-	std::uint64_t p_vaddr;
-	std::uint64_t p_paddr;
-	std::uint64_t p_filesz;
-	std::uint64_t p_memsz;
-	std::uint64_t p_align;
-} __attribute__((packed));
-
-
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bulk.hpp"
+#include "elf.hpp"
+#include "footprint.hpp"
+#include "loader.hpp"
+
+// page-granular size of the mapped segments, not just the sum of p_memsz
+static std::size_t space_of( const struct elf_file *elf ) {
+  struct elf_footprint fp;
+  if ( elf_footprint( elf, 0, &fp ) != 0 )
+    return -1;
+  return fp.vsize;
+}
 
 std::size_t space(const char *name) {
   // Ваш код здесь, name - имя ELF файла, с которым вы работаете
   // вернуть нужно количество байт, необходимых, чтобы загрузить
   // приложение в память
 
-  FILE* elf_fp = fopen( name, "rb" );
-  if ( !elf_fp )
+  struct elf_file elf;
+  if ( elf_open( &elf, name ) != 0 )
     return -1;
 
-  struct elf_hdr elf_file_hdr = {0};
-  // read file header
-  if ( fread( &elf_file_hdr, sizeof( struct elf_hdr ), 1, elf_fp ) != 1 ) {
-    fclose( elf_fp );
-    return -1;
+  const std::size_t size = space_of( &elf );
+  elf_close( &elf );
+	return size;
+}
+
+// печатает размеры секций и итоговые размеры: сколько секции
+// занимают в памяти (SHF_ALLOC) и сколько байт хранится в файле
+static int sections( const struct elf_file *elf ) {
+  // stripped of its section table the image still loads, only
+  // the per-section sizes are unknown
+  if ( elf->shnum == 0 ) {
+    std::cout << "no section header table" << std::endl;
+    return 0;
   }
 
-  // check if elf file
-  if ( elf_file_hdr.e_ident[ 0 ] != 0x7f     // Magic number
-    || elf_file_hdr.e_ident[ 1 ] != 0x45     // E
-    || elf_file_hdr.e_ident[ 2 ] != 0x4c     // L
-    || elf_file_hdr.e_ident[ 3 ] != 0x46 ) { // F
-    fclose( elf_fp );
-    return -1;
+  std::uint64_t file_size = 0;
+  struct elf_shdr shdr;
+  for ( std::size_t i = 0; elf_shdr_at( elf, i, &shdr ) == 0; ++i ) {
+    const char* sname = elf_section_name( elf, &shdr );
+    std::cout << i << "\t" << ( *sname ? sname : "-" ) << "\t" << shdr.sh_size
+      << ( ( shdr.sh_flags & SHF_ALLOC ) ? "\tA" : "" ) << std::endl;
+
+    if ( shdr.sh_type != SHT_NOBITS )
+      file_size += shdr.sh_size;
   }
+  std::cout << "alloc\t" << elf_alloc_size( elf ) << std::endl;
+  std::cout << "file\t" << file_size << std::endl;
+  return 0;
+}
 
-  // jump to the start of program headers
-  if ( fseek( elf_fp, elf_file_hdr.e_phoff, SEEK_SET ) != 0 ) {
-    fclose( elf_fp );
+// печатает space() и размеры секций, файл отображается один раз
+static int space_and_sections( const char *name ) {
+  struct elf_file elf;
+  if ( elf_open( &elf, name ) != 0 ) {
+    std::cout << ( std::size_t ) -1 << std::endl;
     return -1;
   }
 
-  struct elf_phdr prg_hdrs[ elf_file_hdr.e_phnum ];
-  // read program headers
-  if ( fread( prg_hdrs, elf_file_hdr.e_phentsize, elf_file_hdr.e_phnum, elf_fp ) != elf_file_hdr.e_phnum ) {
-    fclose( elf_fp );
+  std::cout << space_of( &elf ) << std::endl;
+  const int ret = sections( &elf );
+  elf_close( &elf );
+  return ret;
+}
+
+// печатает, из каких страниц складывается память, занятая образом
+static int footprint( const char *name ) {
+  struct elf_file elf;
+  if ( elf_open( &elf, name ) != 0 )
+    return -1;
+
+  struct elf_footprint fp;
+  const int ret = elf_footprint( &elf, 0, &fp );
+  elf_close( &elf );
+  if ( ret != 0 )
+    return -1;
+
+  std::cout << "page\t" << fp.page_size << std::endl;
+  std::cout << "span\t" << fp.span << std::endl;
+  std::cout << "vsize\t" << fp.vsize << std::endl;
+  std::cout << "file\t" << fp.file_pages << std::endl;
+  std::cout << "anon\t" << fp.anon_pages << std::endl;
+  std::cout << "shared\t" << fp.shared_pages << std::endl;
+  std::cout << "private\t" << fp.private_pages << std::endl;
+  std::cout << "relro\t" << fp.relro_pages << std::endl;
+  std::cout << "tls\t" << fp.tls_size << std::endl;
+  return 0;
+}
+
+// загружает сегменты и сравнивает предсказание space() с тем,
+// сколько страниц реально стало резидентными
+static int load( const char *name, std::size_t touch_pages ) {
+  // the loader maps the segments from the same descriptor
+  const int fd = open( name, O_RDONLY | O_CLOEXEC );
+  if ( fd < 0 )
+    return -1;
+
+  struct elf_file elf;
+  if ( elf_fdopen( &elf, fd ) != 0 ) {
+    close( fd );
     return -1;
   }
-  fclose( elf_fp );
 
-  std::size_t memsize = 0;
-  for ( std::size_t i = 0; i < elf_file_hdr.e_phnum; ++i )
-    if ( prg_hdrs[ i ].p_type == PT_LOAD )
-      memsize += prg_hdrs[ i ].p_memsz;
+  const std::size_t predicted = space_of( &elf );
+  struct elf_load_report rep;
+  const int ret = predicted == ( std::size_t ) -1 ? -1 : elf_load_file( &elf, fd, touch_pages, &rep );
+  elf_close( &elf );
+  close( fd );
+  if ( ret != 0 )
+    return -1;
 
-	return memsize;
+  std::cout << "predicted\t" << predicted << std::endl;
+  std::cout << "span\t" << rep.span << std::endl;
+  std::cout << "mapped\t" << rep.mapped_pages << std::endl;
+  std::cout << "resident\t" << rep.resident_mapped << std::endl;
+  std::cout << "touched\t" << rep.touched_pages << std::endl;
+  std::cout << "resident-touched\t" << rep.resident_touched << std::endl;
+  std::cout << "resident-bytes\t" << rep.resident_touched * rep.page_size << std::endl;
+  return 0;
 }
 
 int main( int argc, char** argv ) {
+	if ( argc >= 2 && std::strcmp( argv[1], "-b" ) == 0 )
+		return bulk_main( argc - 1, argv + 1 );
+
+	if ( argc == 3 && std::strcmp( argv[1], "-s" ) == 0 ) {
+		return space_and_sections( argv[2] );
+	}
+
+	if ( argc == 3 && std::strcmp( argv[1], "-p" ) == 0 )
+		return footprint( argv[2] );
+
+	if ( ( argc == 3 || argc == 4 ) && std::strcmp( argv[1], "-l" ) == 0 )
+		return load( argv[2], argc == 4 ? std::strtoul( argv[3], NULL, 10 ) : 16 );
+
 	if ( argc != 2 ) {
-		std::cout << "usage: readelf <path-to-elf>" << std::endl;
+		std::cout << "usage: readelf [-s|-p] <path-to-elf>" << std::endl;
+		std::cout << "       readelf -l <path-to-elf> [touch-pages]" << std::endl;
+		std::cout << "       readelf -b [-j <threads>] [-f csv|json] [-c <cache-file>] <path>..." << std::endl;
 		return -1;
 	}
 	
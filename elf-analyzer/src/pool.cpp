@@ -0,0 +1,77 @@
+#include "pool.hpp"
+
+#include <chrono>
+#include <system_error>
+#include <thread>
+
+// failed attempts to find work before an idle worker starts sleeping
+#define IDLE_SPINS 64
+#define IDLE_SLEEP_US 50
+
+work_pool::work_pool( std::size_t nr_workers )
+    : queues( nr_workers ? nr_workers : 1 ), pending( 0 ) {}
+
+void work_pool::push( std::size_t worker, task t ) {
+    worker_queue& q = queues[ worker % queues.size( ) ];
+    pending.fetch_add( 1, std::memory_order_relaxed );
+    std::lock_guard<std::mutex> guard( q.lock );
+    q.tasks.push_back( std::move( t ) );
+}
+
+bool work_pool::pop( std::size_t worker, task& t ) {
+    worker_queue& q = queues[ worker ];
+    std::lock_guard<std::mutex> guard( q.lock );
+    if ( q.tasks.empty( ) )
+        return false;
+    t = std::move( q.tasks.back( ) );
+    q.tasks.pop_back( );
+    return true;
+}
+
+bool work_pool::steal( std::size_t worker, task& t ) {
+    const std::size_t n = queues.size( );
+    for ( std::size_t i = 1; i < n; ++i ) {
+        worker_queue& q = queues[ ( worker + i ) % n ];
+        std::lock_guard<std::mutex> guard( q.lock );
+        if ( q.tasks.empty( ) )
+            continue;
+        // the oldest task is the biggest one for recursive work
+        t = std::move( q.tasks.front( ) );
+        q.tasks.pop_front( );
+        return true;
+    }
+    return false;
+}
+
+void work_pool::loop( std::size_t worker ) {
+    std::size_t misses = 0;
+    task t;
+    // pending drops to zero only after the last task finished, and a
+    // running task pushes its children before it is accounted as done
+    while ( pending.load( std::memory_order_acquire ) > 0 ) {
+        if ( pop( worker, t ) || steal( worker, t ) ) {
+            misses = 0;
+            t( *this, worker );
+            t = nullptr;
+            pending.fetch_sub( 1, std::memory_order_acq_rel );
+        } else if ( ++misses < IDLE_SPINS )
+            std::this_thread::yield( );
+        else std::this_thread::sleep_for( std::chrono::microseconds( IDLE_SLEEP_US ) );
+    }
+}
+
+void work_pool::run( ) {
+    // if the system runs out of threads the ones we got steal the work
+    // queued for the others, so only the parallelism suffers
+    std::vector<std::thread> threads;
+    for ( std::size_t i = 1; i < queues.size( ); ++i ) {
+        try {
+            threads.emplace_back( &work_pool::loop, this, i );
+        } catch ( const std::system_error& ) {
+            break;
+        }
+    }
+    loop( 0 );
+    for ( std::thread& th : threads )
+        th.join( );
+}
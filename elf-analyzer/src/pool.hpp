@@ -0,0 +1,46 @@
+#ifndef _POOL_HPP_
+#define _POOL_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * Work-stealing thread pool. Every worker owns a deque of tasks: it
+ * pushes and pops at the back of its own deque and, once that runs
+ * dry, steals from the front of the others. Tasks may push new tasks
+ * while running, run() returns when no task is queued or running.
+ **/
+class work_pool {
+public:
+    // worker is the index of the worker running the task
+    typedef std::function<void( work_pool& pool, std::size_t worker )> task;
+
+    explicit work_pool( std::size_t nr_workers );
+
+    std::size_t workers( ) const { return queues.size( ); }
+
+    // queue t on the deque of the given worker
+    void push( std::size_t worker, task t );
+
+    // run all tasks on nr_workers threads, the caller becomes worker 0
+    void run( );
+
+private:
+    struct worker_queue {
+        std::mutex lock;
+        std::deque<task> tasks;
+    };
+
+    bool pop( std::size_t worker, task& t );
+    bool steal( std::size_t worker, task& t );
+    void loop( std::size_t worker );
+
+    std::vector<worker_queue> queues;
+    std::atomic<std::size_t> pending; /* queued and running tasks */
+};
+
+#endif // _POOL_HPP_
@@ -0,0 +1,81 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <vector>
+
+// pull in the solution itself, its static functions are what we measure
+#define main logic2phys_main
+#include "../src/main.cpp"
+#undef main
+
+#define NR_PAGES 4096
+#define NR_QUERIES 1000000
+#define NR_REPEATS 5
+
+#define PAGE_SIZE 4096
+#define PRESENT 1
+
+static std::uint64_t lcg_state = 42;
+static std::uint64_t lcg( ) {
+    lcg_state = lcg_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return lcg_state >> 16;
+}
+
+// next free physical page for tables and frames
+static std::size_t next_phys = 0x100000;
+static std::size_t alloc_phys( ) {
+    const std::size_t paddr = next_phys;
+    next_phys += PAGE_SIZE;
+    return paddr;
+}
+
+// installs a mapping of the page laddr lies in, creating missing tables
+static void map_page( std::map<std::size_t, std::size_t>& memory, std::size_t cr3, std::size_t laddr ) {
+    const int shifts[] = { 39, 30, 21, 12 };
+    std::size_t table = cr3;
+    for ( int level = 0; level < 4; ++level ) {
+        const std::size_t entry = table + ( ( ( laddr >> shifts[ level ] ) & PTRS_MASK ) << 3 );
+        if ( memory.count( entry ) == 0 )
+            memory[ entry ] = alloc_phys( ) | PRESENT;
+        table = memory[ entry ] & 0x000ffffffffff000;
+    }
+}
+
+int main( int argc, char** argv ) {
+    std::map<std::size_t, std::size_t> memory;
+    const std::size_t cr3 = alloc_phys( );
+
+    // a few clustered regions like a real address space has
+    std::vector<std::size_t> mapped;
+    for ( std::size_t i = 0; i < NR_PAGES; ++i ) {
+        const std::size_t region = ( lcg( ) % 8 ) << 36;
+        const std::size_t laddr = region + ( lcg( ) % ( NR_PAGES * 4 ) ) * PAGE_SIZE;
+        map_page( memory, cr3, laddr );
+        mapped.push_back( laddr );
+    }
+
+    // nine of ten queries hit a mapped page
+    std::vector<std::size_t> queries;
+    for ( std::size_t i = 0; i < NR_QUERIES; ++i ) {
+        if ( lcg( ) % 10 )
+            queries.push_back( mapped[ lcg( ) % mapped.size( ) ] + lcg( ) % PAGE_SIZE );
+        else queries.push_back( lcg( ) & 0x0000ffffffffffff );
+    }
+
+    double best = 0;
+    std::size_t sink = 0;
+    for ( int r = 0; r < NR_REPEATS; ++r ) {
+        const auto start = std::chrono::steady_clock::now( );
+        for ( std::size_t laddr : queries )
+            sink += logic2phys( cr3, laddr, memory );
+        const double ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now( ) - start ).count( );
+        if ( r == 0 || ns < best )
+            best = ns;
+    }
+
+    std::fprintf( stderr, "checksum %zu\n", sink );
+    std::printf( "logic2phys.walk\t%.3f\t%d\n", best / NR_QUERIES, NR_QUERIES );
+    return 0;
+}
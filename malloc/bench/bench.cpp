@@ -0,0 +1,63 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+// pull in the solution itself, its main only dumps the heap
+#define main malloc_main
+#include "../src/main.cpp"
+#undef main
+
+#define HEAP_SIZE ( 1 << 20 )
+#define NR_SLOTS 512
+#define NR_OPS 200000
+#define NR_REPEATS 5
+
+#define MIN_BLOCK 16
+#define MAX_BLOCK 512
+
+static std::uint64_t lcg_state;
+static std::uint64_t lcg( ) {
+    lcg_state = lcg_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return lcg_state >> 16;
+}
+
+// every op frees the block in a random slot or allocates a new one there
+static std::size_t run_trace( void* heap ) {
+    void* slots[ NR_SLOTS ] = { NULL };
+    std::size_t failed = 0;
+
+    lcg_state = 42;
+    mysetup( heap, HEAP_SIZE );
+    for ( std::size_t i = 0; i < NR_OPS; ++i ) {
+        void*& slot = slots[ lcg( ) % NR_SLOTS ];
+        if ( slot ) {
+            myfree( slot );
+            slot = NULL;
+        } else {
+            slot = myalloc( MIN_BLOCK + lcg( ) % ( MAX_BLOCK - MIN_BLOCK ) );
+            failed += slot == NULL;
+        }
+    }
+    return failed;
+}
+
+int main( int argc, char** argv ) {
+    void* heap = malloc( HEAP_SIZE );
+
+    double best = 0;
+    std::size_t failed = 0;
+    for ( int r = 0; r < NR_REPEATS; ++r ) {
+        const auto start = std::chrono::steady_clock::now( );
+        failed = run_trace( heap );
+        const double ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now( ) - start ).count( );
+        if ( r == 0 || ns < best )
+            best = ns;
+    }
+
+    std::fprintf( stderr, "failed allocations %zu\n", failed );
+    std::printf( "malloc.trace\t%.3f\t%d\n", best / NR_OPS, NR_OPS );
+    free( heap );
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+// pull in the solution itself, its main only runs a tiny example
+#define main rrobin_main
+#include "../src/main.cpp"
+#undef main
+
+#define NR_EVENTS 2000000
+#define NR_REPEATS 5
+#define MAX_THREADS 64
+#define TIMESLICE 3
+
+static std::uint64_t lcg_state;
+static std::uint64_t lcg( ) {
+    lcg_state = lcg_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return lcg_state >> 16;
+}
+
+// mostly timer ticks with threads coming, blocking, waking and going,
+// the driver keeps track of blocked threads to only wake those
+static long run_trace( ) {
+    std::vector<int> blocked;
+    int next_id = 0, alive = 0;
+    long sink = 0;
+
+    lcg_state = 42;
+    scheduler_setup( TIMESLICE );
+    for ( std::size_t i = 0; i < NR_EVENTS; ++i ) {
+        const unsigned event = lcg( ) % 100;
+        if ( event < 70 )
+            timer_tick( );
+        else if ( event < 75 ) {
+            if ( alive < MAX_THREADS ) {
+                new_thread( next_id++ );
+                alive++;
+            }
+        } else if ( event < 85 ) {
+            const int id = current_thread( );
+            if ( id != -1 ) {
+                block_thread( );
+                blocked.push_back( id );
+            }
+        } else if ( event < 95 ) {
+            if ( !blocked.empty( ) ) {
+                const std::size_t at = lcg( ) % blocked.size( );
+                wake_thread( blocked[ at ] );
+                blocked[ at ] = blocked.back( );
+                blocked.pop_back( );
+            }
+        } else if ( current_thread( ) != -1 ) {
+            exit_thread( );
+            alive--;
+        }
+        sink += current_thread( );
+    }
+    return sink;
+}
+
+int main( int argc, char** argv ) {
+    double best = 0;
+    long sink = 0;
+    for ( int r = 0; r < NR_REPEATS; ++r ) {
+        const auto start = std::chrono::steady_clock::now( );
+        sink += run_trace( );
+        const double ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now( ) - start ).count( );
+        if ( r == 0 || ns < best )
+            best = ns;
+    }
+
+    std::fprintf( stderr, "checksum %ld\n", sink );
+    std::printf( "round-robin.trace\t%.3f\t%d\n", best / NR_EVENTS, NR_EVENTS );
+    return 0;
+}
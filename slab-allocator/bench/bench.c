@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* pull in the solution itself, it expects the buddy allocator below */
+#include "../src/main.c"
+
+#define NR_SLOTS 4096
+#define NR_OPS 1000000
+#define NR_REPEATS 5
+#define SHRINK_PERIOD 65536
+
+static long nr_slabs = 0; /* slabs not yet given back */
+
+/**
+ * Stand-in for the buddy allocator of the checking system, the slab
+ * has to be aligned on its own size.
+ **/
+void* alloc_slab(int order)
+{
+    const size_t size = BUDDY_PAGE_SIZE * ( 1UL << order );
+    nr_slabs++;
+    return aligned_alloc( size, size );
+}
+
+void free_slab(void *slab)
+{
+    nr_slabs--;
+    free( slab );
+}
+
+static uint64_t lcg_state;
+static uint64_t lcg( void ) {
+    lcg_state = lcg_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return lcg_state >> 16;
+}
+
+static double now_ns( void ) {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* every op frees the object in a random slot or allocates a new one there */
+static void run_churn( size_t object_size ) {
+    static void* slots[ NR_SLOTS ];
+    struct cache cache;
+
+    lcg_state = 42;
+    cache_setup( &cache, object_size );
+    for ( size_t i = 0; i < NR_SLOTS; ++i )
+        slots[ i ] = NULL;
+
+    for ( size_t i = 0; i < NR_OPS; ++i ) {
+        void** slot = &slots[ lcg( ) % NR_SLOTS ];
+        if ( *slot ) {
+            cache_free( &cache, *slot );
+            *slot = NULL;
+        } else *slot = cache_alloc( &cache );
+
+        if ( i % SHRINK_PERIOD == SHRINK_PERIOD - 1 )
+            cache_shrink( &cache );
+    }
+
+    for ( size_t i = 0; i < NR_SLOTS; ++i )
+        if ( slots[ i ] )
+            cache_free( &cache, slots[ i ] );
+    cache_release( &cache );
+}
+
+static void bench( const char* name, size_t object_size ) {
+    double best = 0;
+    for ( int r = 0; r < NR_REPEATS; ++r ) {
+        const double start = now_ns( );
+        run_churn( object_size );
+        const double ns = now_ns( ) - start;
+        if ( r == 0 || ns < best )
+            best = ns;
+    }
+    if ( nr_slabs != 0 )
+        fprintf( stderr, "%s: %ld slabs leaked\n", name, nr_slabs );
+    printf( "%s\t%.3f\t%d\n", name, best / NR_OPS, NR_OPS );
+}
+
+int main( void ) {
+    bench( "slab.churn.32", 32 );
+    bench( "slab.churn.256", 256 );
+    bench( "slab.churn.2048", 2048 );
+    return 0;
+}